@@ -0,0 +1,169 @@
+#include <cstring>
+#include <queue>
+#include "aho_corasick.h"
+#include "block_io.h"
+
+aho_corasick::aho_corasick(const list<string> &patterns) {
+    build_classes(patterns);
+    build_dfa(patterns);
+}
+
+void aho_corasick::build_classes(const list<string> &patterns) {
+    classes.assign(256, 0); // class 0 holds every byte that no pattern uses
+
+    for (auto &p : patterns)
+        for (auto &c : p) {
+            auto uc = static_cast<unsigned char>(c);
+            if (classes[uc] == 0)
+                classes[uc] = class_count++;
+        }
+
+    while ((static_cast<size_t>(1) << row_shift) < class_count)
+        ++row_shift;
+}
+
+void aho_corasick::build_dfa(const list<string> &patterns) {
+    const size_t k = static_cast<size_t>(1) << row_shift; // rows padded to a power of two
+
+    delta.assign(k, 0);
+    out_count.assign(1, 0);
+
+    for (auto &p : patterns) {
+        if (p.empty())
+            continue;
+
+        size_t s = 0;
+        for (auto &c : p) {
+            size_t i = s * k + classes[static_cast<unsigned char>(c)];
+            if (delta[i] == 0) {
+                delta[i] = out_count.size();
+                delta.resize(delta.size() + k, 0);
+                out_count.push_back(0);
+            }
+            s = delta[i];
+        }
+        ++out_count[s];
+    }
+
+    vector<uint32_t> fail(out_count.size(), 0);
+    queue<uint32_t> q;
+
+    for (size_t c = 0; c < class_count; ++c)
+        if (delta[c] != 0)
+            q.push(delta[c]);
+
+    while (!q.empty()) {
+        uint32_t u = q.front();
+        q.pop();
+
+        for (size_t c = 0; c < class_count; ++c) {
+            uint32_t v = delta[u * k + c];
+            if (v != 0) {
+                fail[v] = delta[fail[u] * k + c];
+                out_count[v] += out_count[fail[v]];
+                q.push(v);
+            } else {
+                delta[u * k + c] = delta[fail[u] * k + c];
+            }
+        }
+    }
+
+    // store row offsets instead of state ids, flagging transitions into states that end a pattern
+    for (auto &t : delta)
+        t = static_cast<uint32_t>(t * k) | (out_count[t] > 0 ? hit_flag : 0);
+}
+
+inline size_t aho_corasick::hit_count(uint32_t s) const {
+    return out_count[(s & state_mask) >> row_shift];
+}
+
+size_t aho_corasick::search(bool print, istream &in) {
+    block_reader reader(in);
+
+    const uint32_t *d = delta.data();
+    const uint32_t *cls = classes.data();
+    auto step = [d, cls](uint32_t s, char c) {
+        return d[(s & state_mask) + cls[static_cast<unsigned char>(c)]];
+    };
+
+    size_t no_occ = 0;
+    size_t hits = 0;
+    uint32_t s = 0;
+    string carry;
+
+    auto emit = [&](const char *line, const char *end) {
+        for (size_t h = 0; h < hits; ++h) {
+            cout << carry;
+            cout.write(line, end - line);
+            cout << '\n';
+        }
+        no_occ += hits;
+        hits = 0;
+        carry.clear();
+    };
+
+    string_view block;
+    while (!(block = reader.next()).empty()) {
+        const char *p = block.data();
+        const char *e = p + block.size();
+
+        if (!print) {
+            while (p < e) {
+                s = step(s, *p++);
+                if (s & hit_flag)
+                    no_occ += hit_count(s);
+            }
+            continue;
+        }
+
+        const char *line = p;
+        while (p < e) {
+            if (hits == 0) {
+                while (p < e) {
+                    s = step(s, *p++);
+                    if (s & hit_flag)
+                        break;
+                }
+                if (!(s & hit_flag))
+                    break;
+
+                auto nl = static_cast<const char *>(memrchr(line, '\n', p - 1 - line));
+                if (nl) {
+                    carry.clear();
+                    line = nl + 1;
+                }
+                hits += hit_count(s);
+            }
+
+            auto nl = static_cast<const char *>(memchr(p, '\n', e - p));
+            const char *stop = nl ? nl : e;
+            while (p < stop) {
+                s = step(s, *p++);
+                if (s & hit_flag)
+                    hits += hit_count(s);
+            }
+
+            if (!nl)
+                break;
+
+            emit(line, nl);
+            s = step(s, *p++);
+            line = p;
+        }
+
+        // keep the unfinished line for the next block
+        auto nl = static_cast<const char *>(memrchr(line, '\n', e - line));
+        if (nl) {
+            carry.clear();
+            line = nl + 1;
+        }
+        carry.append(line, e - line);
+    }
+
+    if (hits > 0)
+        emit(carry.data() + carry.size(), carry.data() + carry.size());
+
+    cout.flush();
+
+    return no_occ;
+}
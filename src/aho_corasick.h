@@ -0,0 +1,36 @@
+#ifndef IPMT_AHO_CORASICK_H
+#define IPMT_AHO_CORASICK_H
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Aho-Corasick DFA over the byte classes that occur in the patterns, used to search a text without an index
+class aho_corasick {
+private:
+    static const uint32_t hit_flag = static_cast<uint32_t>(1) << static_cast<uint32_t>(31);
+    static const uint32_t state_mask = hit_flag - 1;
+
+    vector<uint32_t> classes;
+    size_t class_count = 1;
+    size_t row_shift = 0;
+    vector<uint32_t> delta;
+    vector<size_t> out_count;
+
+    size_t hit_count(uint32_t s) const;
+
+    void build_classes(const list<string> &patterns);
+
+    void build_dfa(const list<string> &patterns);
+
+public:
+    explicit aho_corasick(const list<string> &patterns);
+
+    size_t search(bool print, istream &in);
+};
+
+#endif //IPMT_AHO_CORASICK_H
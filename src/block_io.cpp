@@ -0,0 +1,106 @@
+#include <cstring>
+#include "block_io.h"
+
+block_reader::block_reader(istream &in, size_t block_size) : in(in), front(block_size, '\0'),
+                                                             back(block_size, '\0') {
+    prefetch();
+}
+
+block_reader::~block_reader() {
+    if (pending.valid())
+        pending.wait();
+}
+
+void block_reader::prefetch() {
+    pending = async(launch::async, [this]() {
+        in.read(&back[0], back.size());
+        return static_cast<size_t>(in.gcount());
+    });
+}
+
+bool block_reader::advance() {
+    if (!pending.valid())
+        return false;
+
+    size_t got = pending.get();
+    if (got == 0)
+        return false;
+
+    swap(front, back);
+    front_pos = 0;
+    front_len = got;
+
+    if (got == front.size())
+        prefetch();
+
+    return true;
+}
+
+size_t block_reader::read(char *dst, size_t count) {
+    size_t total = 0;
+
+    while (total < count) {
+        if (front_pos == front_len && !advance())
+            break;
+
+        size_t len = min(count - total, front_len - front_pos);
+        memcpy(dst + total, front.data() + front_pos, len);
+        front_pos += len;
+        total += len;
+    }
+
+    return total;
+}
+
+string_view block_reader::next() {
+    if (front_pos == front_len && !advance())
+        return string_view();
+
+    string_view block{front.data() + front_pos, front_len - front_pos};
+    front_pos = front_len;
+
+    return block;
+}
+
+block_writer::block_writer(ostream &out, size_t block_size) : out(out), front(block_size, '\0'),
+                                                              back(block_size, '\0') {}
+
+block_writer::~block_writer() {
+    flush();
+}
+
+void block_writer::dispatch() {
+    if (pending.valid())
+        pending.get();
+
+    swap(front, back);
+    size_t len = front_len;
+    front_len = 0;
+
+    pending = async(launch::async, [this, len]() {
+        out.write(back.data(), len);
+    });
+}
+
+void block_writer::write(const char *src, size_t count) {
+    while (count > 0) {
+        size_t len = min(count, front.size() - front_len);
+        memcpy(&front[front_len], src, len);
+        front_len += len;
+        src += len;
+        count -= len;
+
+        if (front_len == front.size())
+            dispatch();
+    }
+}
+
+void block_writer::flush() {
+    if (front_len > 0)
+        dispatch();
+
+    if (pending.valid())
+        pending.get();
+
+    out.flush();
+}
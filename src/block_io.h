@@ -0,0 +1,59 @@
+#ifndef IPMT_BLOCK_IO_H
+#define IPMT_BLOCK_IO_H
+
+#include <future>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Double-buffered reader: the next block is read in the background while the current one is consumed
+class block_reader {
+private:
+    istream &in;
+    string front;
+    string back;
+    size_t front_pos = 0;
+    size_t front_len = 0;
+    future<size_t> pending;
+
+    void prefetch();
+
+    bool advance();
+
+public:
+    static const size_t default_block_size = static_cast<size_t>(1) << static_cast<size_t>(20); // 1 MiB
+
+    explicit block_reader(istream &in, size_t block_size = default_block_size);
+
+    ~block_reader();
+
+    size_t read(char *dst, size_t count);
+
+    string_view next();
+};
+
+// Double-buffered writer: a full block is written in the background while the next one is filled
+class block_writer {
+private:
+    ostream &out;
+    string front;
+    string back;
+    size_t front_len = 0;
+    future<void> pending;
+
+    void dispatch();
+
+public:
+    static const size_t default_block_size = static_cast<size_t>(1) << static_cast<size_t>(20); // 1 MiB
+
+    explicit block_writer(ostream &out, size_t block_size = default_block_size);
+
+    ~block_writer();
+
+    void write(const char *src, size_t count);
+
+    void flush();
+};
+
+#endif //IPMT_BLOCK_IO_H
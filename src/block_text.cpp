@@ -0,0 +1,96 @@
+#include "block_text.h"
+#include "lz77.h"
+
+block_text::block_text(const string_view &txt, size_t block_size) : n(txt.size()), block_size(block_size) {
+    offsets.push_back(0);
+
+    for (size_t i = 0; i < n; i += block_size) {
+        lz77::zip_block(txt.substr(i, block_size), data);
+        offsets.push_back(data.size());
+    }
+}
+
+size_t block_text::size() const {
+    return n;
+}
+
+const string &block_text::block(size_t b) {
+    if (!cache.empty() && cache.front().first == b)
+        return cache.front().second;
+
+    auto it = cache_index.find(b);
+    if (it != cache_index.end()) {
+        cache.splice(cache.begin(), cache, it->second);
+        return cache.front().second;
+    }
+
+    if (cache.size() == cache_capacity) {
+        cache_index.erase(cache.back().first);
+        cache.pop_back();
+    }
+
+    string_view src{data.data() + offsets[b], offsets[b + 1] - offsets[b]};
+    cache.emplace_front(b, string());
+    lz77::unzip_block(src, min(block_size, n - b * block_size), cache.front().second);
+    cache_index[b] = cache.begin();
+
+    return cache.front().second;
+}
+
+char block_text::operator[](size_t i) {
+    return block(i / block_size)[i % block_size];
+}
+
+size_t block_text::lcp(size_t pos, const string_view &pat, size_t start_from) {
+    const size_t m = pat.size();
+    size_t i = start_from;
+
+    while (i < m && pos + i < n) {
+        size_t b = (pos + i) / block_size;
+        size_t off = (pos + i) % block_size;
+        const string &blk = block(b);
+
+        while (i < m && off < blk.size() && blk[off] == pat[i]) {
+            ++i;
+            ++off;
+        }
+
+        if (off < blk.size())
+            break;
+    }
+
+    return i;
+}
+
+void block_text::save(ostream &out) const {
+    size_t size;
+
+    out.write(reinterpret_cast<const char *>(&n), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(&block_size), sizeof(size_t));
+
+    size = offsets.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(offsets.data()), sizeof(size_t) * size);
+
+    size = data.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
+    out.write(data.data(), size);
+}
+
+void block_text::load(istream &in) {
+    size_t size;
+
+    in.read(reinterpret_cast<char *>(&n), sizeof(size_t));
+    in.read(reinterpret_cast<char *>(&block_size), sizeof(size_t));
+
+    in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    offsets.resize(size);
+    in.read(reinterpret_cast<char *>(offsets.data()), sizeof(size_t) * size);
+
+    in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    data.resize(size);
+    in.read(&data[0], size);
+
+    cache.clear();
+    cache_index.clear();
+}
@@ -0,0 +1,45 @@
+#ifndef IPMT_BLOCK_TEXT_H
+#define IPMT_BLOCK_TEXT_H
+
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Text stored as independently decodable lz77 blocks, decoded on demand through a small LRU cache
+class block_text {
+private:
+    static const size_t cache_capacity = 16;
+
+    size_t n = 0;
+    size_t block_size = 0;
+    vector<size_t> offsets;
+    string data;
+
+    list<pair<size_t, string>> cache;
+    unordered_map<size_t, list<pair<size_t, string>>::iterator> cache_index;
+
+    const string &block(size_t b);
+
+public:
+    static const size_t default_block_size = static_cast<size_t>(1) << static_cast<size_t>(16); // 64 KiB
+
+    block_text() = default;
+
+    explicit block_text(const string_view &txt, size_t block_size = default_block_size);
+
+    size_t size() const;
+
+    char operator[](size_t i);
+
+    size_t lcp(size_t pos, const string_view &pat, size_t start_from);
+
+    void save(ostream &out) const;
+
+    void load(istream &in);
+};
+
+#endif //IPMT_BLOCK_TEXT_H
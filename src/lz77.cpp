@@ -1,5 +1,8 @@
+#include <cstdint>
+#include <cstring>
 #include <tuple>
 #include "lz77.h"
+#include "block_io.h"
 
 
 void lz77::build_fsm(vector<size_t> &fsm, const string_view &pat) {
@@ -36,7 +39,7 @@ pair<size_t, size_t> lz77::prefix_match(const string_view &win, const string_vie
     for (auto &w : win) {
         cur = fsm[256 * cur + static_cast<unsigned char>(w)];
         if (cur > len && i - cur + 1 < n - m) {
-            len = cur;
+            len = min(cur, m - 1); // keep room for the literal
             pos = i - cur + 1;
             if (len == m - 1)
                 break;
@@ -47,16 +50,62 @@ pair<size_t, size_t> lz77::prefix_match(const string_view &win, const string_vie
     return pair<size_t, size_t>(pos, len);
 }
 
-void lz77::zip(const string_view &txt, ostream &out) {
-    const size_t n = txt.size();
+size_t lz77::encode_token(const string_view &win, const string_view &pat, char *token) {
+    size_t pos, len;
+    tie(pos, len) = prefix_match(win, pat);
+
+    auto store = static_cast<uint16_t>(pos << static_cast<size_t>(7) | len);
+    memcpy(token, &store, 2);
+    token[2] = pat[len];
+
+    return len + 1;
+}
+
+void lz77::zip(istream &in, ostream &out, size_t n) {
     out.write(reinterpret_cast<const char *>(&n), sizeof(size_t));
 
-    string pre_txt;
-    pre_txt.resize(ls_size + n);
-    fill(pre_txt.begin(), pre_txt.begin() + ls_size, '\0');
+    block_reader reader(in);
+    block_writer writer(out);
+
+    string buf(ls_size + buf_size, '\0');
+    string_view bufv{buf.data(), buf.size()};
+
+    string_view win, pat;
+    size_t i = ls_size, end = ls_size;
+    bool eof = false;
+    while (true) {
+        if (!eof && end - i < la_size) { // slide the window and refill the look-ahead
+            size_t from = i - ls_size;
+            copy(buf.begin() + from, buf.begin() + end, buf.begin());
+            i -= from;
+            end -= from;
+
+            size_t got = reader.read(&buf[end], buf.size() - end);
+            eof = got < buf.size() - end;
+            end += got;
+        }
+
+        if (i >= end)
+            break;
+
+        win = bufv.substr(i - ls_size, min(la_size + ls_size, end - (i - ls_size)));
+        pat = bufv.substr(i, min(la_size, end - i));
+
+        char token[token_size];
+        i += encode_token(win, pat, token);
+        writer.write(token, token_size);
+    }
+
+    writer.flush();
+}
+
+void lz77::zip_block(const string_view &txt, string &out) {
+    const size_t n = txt.size();
+
+    string pre_txt(ls_size + n, '\0');
     copy(txt.begin(), txt.end(), pre_txt.begin() + ls_size);
 
-    string_view pre_txtv{pre_txt.c_str(), pre_txt.size()};
+    string_view pre_txtv{pre_txt.data(), pre_txt.size()};
 
     string_view win, pat;
     size_t i = ls_size;
@@ -64,49 +113,109 @@ void lz77::zip(const string_view &txt, ostream &out) {
         win = pre_txtv.substr(i - ls_size, la_size + ls_size);
         pat = pre_txtv.substr(i, la_size);
 
-        size_t pos, len;
-        tie(pos, len) = prefix_match(win, pat);
-        char c = pat[len];
+        char token[token_size];
+        i += encode_token(win, pat, token);
+        out.append(token, token_size);
+    }
+}
+
+inline void lz77::copy_match(char *dst, const char *ref, size_t len) {
+    char *end = dst + len;
+
+    // short distance: double the repeated pattern until wild copies no longer overlap
+    while (dst - ref < 16) {
+        memcpy(dst, ref, dst - ref);
+        dst += dst - ref;
+        if (dst >= end)
+            return;
+    }
+
+    if (dst - ref >= 32) {
+        do {
+            memcpy(dst, ref, 32);
+            dst += 32;
+            ref += 32;
+        } while (dst < end);
+    } else {
+        do {
+            memcpy(dst, ref, 16);
+            dst += 16;
+            ref += 16;
+        } while (dst < end);
+    }
+}
 
-        size_t store = 0;
-        store |= pos << static_cast<size_t>(7);
-        store |= len;
+void lz77::decode(const char *&src, const char *src_end, char *&dst, const char *dst_limit) {
+    const char *s = src;
+    char *d = dst;
 
-        out.write(reinterpret_cast<const char *>(&store), 2);
-        out.write(reinterpret_cast<const char *>(&c), sizeof(char));
+    while (s < src_end && d < dst_limit) {
+        uint16_t store;
+        memcpy(&store, s, 2);
 
-        i += len + 1;
+        size_t pos = store >> static_cast<size_t>(7);
+        size_t len = store & (la_size - 1);
+
+        if (len > 0) {
+            copy_match(d, d - ls_size + pos, len);
+            d += len;
+        }
+
+        *d++ = s[2];
+        s += token_size;
     }
+
+    src = s;
+    dst = d;
 }
 
-void lz77::unzip(istream &in) {
-    size_t n = 0;
+void lz77::unzip(istream &in, ostream &out) {
+    size_t n = unknown_size;
     in.read(reinterpret_cast<char *>(&n), sizeof(size_t));
 
-    string txt;
-    txt.resize(n + ls_size);
+    block_reader reader(in);
+    block_writer writer(out);
 
-    fill(txt.begin(), txt.begin() + ls_size, 'x');
+    string src_buf(buf_size / token_size * token_size, '\0');
+    string buf(ls_size + buf_size + slack_size, '\0');
 
-    size_t pos, len;
-    char c;
-    size_t store = 0;
-    size_t i = ls_size;
-    while (i < txt.size()) {
-        in.read(reinterpret_cast<char *>(&store), 2);
-        in.read(reinterpret_cast<char *>(&c), sizeof(char));
+    char *const base = &buf[0];
+    const char *const dst_limit = base + ls_size + buf_size;
+    char *dst = base + ls_size;
 
-        pos = store >> static_cast<size_t>(7);
-        len = store & (static_cast<size_t>(-1) >> static_cast<size_t>(64 - 7));
+    size_t written = 0;
+    auto drain = [&]() {
+        size_t len = min(static_cast<size_t>(dst - base) - ls_size, n - written);
+        writer.write(base + ls_size, len);
+        written += len;
 
-        for (size_t j = 0; j < len; ++j) {
-            txt[i] = txt[i - ls_size + pos];
-            ++i;
-        }
+        memmove(base, dst - ls_size, ls_size);
+        dst = base + ls_size;
+    };
 
-        txt[i] = c;
-        ++i;
+    size_t got;
+    while (written < n && (got = reader.read(&src_buf[0], src_buf.size())) >= token_size) {
+        const char *src = src_buf.data();
+        const char *src_end = src + got / token_size * token_size;
+
+        while (src < src_end) {
+            decode(src, src_end, dst, dst_limit);
+            if (dst >= dst_limit)
+                drain();
+        }
     }
-    string_view txtv{txt.c_str(), txt.size()};
-    cout << txtv.substr(ls_size) << endl;
+    drain();
+
+    writer.flush();
+}
+
+void lz77::unzip_block(const string_view &src, size_t n, string &out) {
+    out.assign(ls_size + n + slack_size, '\0');
+
+    const char *s = src.data();
+    char *dst = &out[ls_size];
+    decode(s, s + src.size() / token_size * token_size, dst, out.data() + ls_size + n);
+
+    out.erase(0, ls_size);
+    out.resize(n);
 }
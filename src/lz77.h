@@ -12,16 +12,30 @@ class lz77 {
 private:
     static const size_t ls_size = static_cast<size_t>(1) << static_cast<size_t>(9); // 512
     static const size_t la_size = static_cast<size_t>(1) << static_cast<size_t>(7); // 128
+    static const size_t buf_size = static_cast<size_t>(1) << static_cast<size_t>(20); // 1 MiB
+    static const size_t token_size = 3;
+    static const size_t slack_size = la_size + 64; // room for a whole token plus wild-copy overrun
 
     static void build_fsm(vector<size_t> &fsm, const string_view &pat);
 
     static pair<size_t, size_t> prefix_match(const string_view &win, const string_view &pat);
 
+    static size_t encode_token(const string_view &win, const string_view &pat, char *token);
+
+    static void copy_match(char *dst, const char *ref, size_t len);
+
+    static void decode(const char *&src, const char *src_end, char *&dst, const char *dst_limit);
+
 public:
+    static const size_t unknown_size = static_cast<size_t>(-1);
+
+    static void zip(istream &in, ostream &out, size_t n = unknown_size);
+
+    static void unzip(istream &in, ostream &out);
 
-    static void zip(const string_view &txt, ostream &out);
+    static void zip_block(const string_view &txt, string &out);
 
-    static void unzip(istream &in);
+    static void unzip_block(const string_view &src, size_t n, string &out);
 };
 
 #endif //IMPT_LZ77_H
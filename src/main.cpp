@@ -1,7 +1,9 @@
 #include <string_view>
 #include "suffix_array.h"
 #include "lz77.h"
+#include "aho_corasick.h"
 #include <getopt.h>
+#include <filesystem>
 #include <list>
 #include <functional>
 #include <iostream>
@@ -14,6 +16,7 @@ using namespace std;
 enum options {
     DEFAULT = 0x00,
     COUNT = 0x01,
+    SORTED = 0x02,
 };
 
 void help_index(char *s) {
@@ -22,6 +25,7 @@ void help_index(char *s) {
             << "Create an indexfile named after the given textfile with suffix '.idx' using the suffix-array algorithm"
             << endl
             << "Options:" << endl
+            << "  -z, --lz77    store the text as lz77 blocks that are decompressed on demand while searching" << endl
             << "  -h, --help    display this information" << endl
             << endl
             << "Example: " << s << " index moby-dick.txt" << endl
@@ -38,35 +42,91 @@ void help_search(char *s) {
             << "  -p, --pattern FILE    obtain patterns (per line) from FILE" << endl
             << "  -c, --count           only print the total count of occurrences" << endl
             << "  -l, --line_count      only print the total count of lines that has occurrences" << endl
+            << "  -s, --sorted          print occurrences in text order" << endl
+            << "  -m, --max N           stop after N occurrences" << endl
+            << "  -o, --offset K        skip the first K occurrences" << endl
             << "  -h, --help            display this information" << endl
             << endl
+            << "With --max or --offset, --count counts only the occurrences on that page" << endl
+            << endl
             << "Example: " << s << " search whale moby-dick.idx" << endl
+            << "         " << s << " search --sorted --max 100 --offset 200 whale moby-dick.idx" << endl
+            << endl;
+}
+
+void help_stats(char *s) {
+    cerr
+            << "Usage: " << s << " stats [options] query indexfile" << endl
+            << endl
+            << "Report repeat and substring statistics from indexfile" << endl
+            << endl
+            << "Queries:" << endl
+            << "  longest     longest repeated substrings" << endl
+            << "  repeats     maximal repeats of at least --length characters occurring at least --freq times" << endl
+            << "  top         the --top most frequent substrings of exactly --length characters" << endl
+            << "  distinct    number of distinct substrings" << endl
+            << endl
+            << "Repeats are printed as length, occurrences and substring separated by tabs;" << endl
+            << "top substrings as occurrences and substring" << endl
+            << endl
+            << "Options:" << endl
+            << "  -l, --length N    substring length (default 10)" << endl
+            << "  -f, --freq N      minimum number of occurrences (default 2)" << endl
+            << "  -k, --top K       number of substrings to report (default 10)" << endl
+            << "  -h, --help        display this information" << endl
+            << endl
+            << "Example: " << s << " stats repeats -l 40 moby-dick.idx" << endl
+            << "         " << s << " stats top -l 5 -k 20 moby-dick.idx" << endl
+            << endl;
+}
+
+void help_grep(char *s) {
+    cerr
+            << "Usage: " << s << " grep [options] pattern [textfile]" << endl
+            << endl
+            << "Search for pattern scanning textfile directly, without an indexfile" << endl
+            << "With no textfile, or when textfile is -, read standard input" << endl
+            << endl
+            << "Options:" << endl
+            << "  -p, --pattern FILE    obtain patterns (per line) from FILE" << endl
+            << "  -c, --count           only print the total count of occurrences" << endl
+            << "  -h, --help            display this information" << endl
+            << endl
+            << "Example: " << s << " grep whale moby-dick.txt" << endl
+            << "         " << s << " grep -p patterns.txt moby-dick.txt" << endl
             << endl;
 }
 
 void help_zip(char *s) {
     cerr
-            << "Usage: " << s << " zip [options] textfile" << endl
+            << "Usage: " << s << " zip [options] [textfile]" << endl
             << endl
             << "zip textfile using lz77 algorithm producing textfile.lz77" << endl
+            << "With no textfile, or when textfile is -, read standard input and write standard output" << endl
             << endl
             << "Options:" << endl
+            << "  -c, --stdout  write to standard output" << endl
             << "  -h, --help    display this information" << endl
             << endl
             << "Example: " << s << " zip moby-dick.txt" << endl
+            << "         cat moby-dick.txt | " << s << " zip > moby-dick.txt.lz77" << endl
             << endl;
 }
 
 void help_unzip(char *s) {
     cerr
-            << "Usage: " << s << " unzip [options] textfile.lz77" << endl
+            << "Usage: " << s << " unzip [options] [textfile.lz77]" << endl
             << endl
             << "Unzip textfile.lz77 using lz77 algorithm producing textfile" << endl
+            << "With no textfile.lz77, or when textfile.lz77 is -, read standard input and write standard output"
+            << endl
             << endl
             << "Options:" << endl
+            << "  -c, --stdout  write to standard output" << endl
             << "  -h, --help    display this information" << endl
             << endl
-            << "Example: " << s << " unzip moby-dick.txt.lz77" << endl;
+            << "Example: " << s << " unzip moby-dick.txt.lz77" << endl
+            << "         " << s << " unzip -c moby-dick.txt.lz77 | grep whale" << endl;
 }
 
 void help(char *s) {
@@ -84,6 +144,16 @@ void help(char *s) {
             << "For more info run: " << s << " search -h"
             << endl
             << endl
+            << "Report repeat and substring statistics from indexfile"
+            << endl
+            << "For more info run: " << s << " stats -h"
+            << endl
+            << endl
+            << "Search for pattern scanning textfile directly, without an indexfile"
+            << endl
+            << "For more info run: " << s << " grep -h"
+            << endl
+            << endl
             << "Zip textfile using lz77 algorithm producing textfile.lz77"
             << endl
             << "For more info run: " << s << " zip -h"
@@ -104,18 +174,30 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    switch (argv[1][0]) {
+    char command = argv[1][0];
+    if (string(argv[1]).rfind("st", 0) == 0) // 'stats' shares its first letter with 'search'
+        command = 'S';
+
+    switch (command) {
         case 'i': { // index
-            const char *short_options = ":h";
+            const char *short_options = ":zh";
             const option long_options[] = {
+                    {"lz77",  no_argument, nullptr, 'z'},
                     {"help",  no_argument, nullptr, 'h'},
                     {nullptr, no_argument, nullptr, '\0'},
             };
             int option_index = -1;
 
+            bool compress = false;
+
             int c;
             while ((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1) {
                 switch (c) {
+                    case 'z': {
+                        compress = true;
+                        break;
+                    }
+
                     case 'h':
                     case '?':
                     default: {
@@ -134,16 +216,19 @@ int main(int argc, char *argv[]) {
             string_view strv{str.c_str(), str.size()};
 
             auto sa = new suffix_array(strv);
-            sa->save(out_file);
+            sa->save(out_file, compress);
 
             return 0;
         }
 
         case 's': { // search
-            const char *short_options = "p:ch";
+            const char *short_options = "p:csm:o:h";
             const option long_options[] = {
                     {"pattern", required_argument, nullptr, 'p'},
                     {"count",   no_argument,       nullptr, 'c'},
+                    {"sorted",  no_argument,       nullptr, 's'},
+                    {"max",     required_argument, nullptr, 'm'},
+                    {"offset",  required_argument, nullptr, 'o'},
                     {"help",    no_argument,       nullptr, 'h'},
                     {nullptr,   no_argument,       nullptr, '\0'},
             };
@@ -151,6 +236,8 @@ int main(int argc, char *argv[]) {
 
             size_t e = 0;
             size_t m = options::DEFAULT;
+            size_t max_occ = suffix_array::unlimited;
+            size_t offset = 0;
 
             list <string> patterns;
             queue < unique_ptr < istream, function < void(istream * ) >> > t;
@@ -171,6 +258,21 @@ int main(int argc, char *argv[]) {
                         break;
                     }
 
+                    case 's': {
+                        m |= options::SORTED;
+                        break;
+                    }
+
+                    case 'm': {
+                        max_occ = stoul(optarg);
+                        break;
+                    }
+
+                    case 'o': {
+                        offset = stoul(optarg);
+                        break;
+                    }
+
                     case 'h':
                     case '?':
                     default: {
@@ -196,24 +298,173 @@ int main(int argc, char *argv[]) {
             auto sa = new suffix_array();
 
             if (m & options::COUNT)
-                cout << sa->search(false, idx_file, patterns);
+                cout << sa->search(false, idx_file, patterns, offset, max_occ);
             else
-                sa->search(true, idx_file, patterns);
+                sa->search(true, idx_file, patterns, offset, max_occ, m & options::SORTED);
+
+            return 0;
+        }
+
+        case 'S': { // stats
+            const char *short_options = "l:f:k:h";
+            const option long_options[] = {
+                    {"length", required_argument, nullptr, 'l'},
+                    {"freq",   required_argument, nullptr, 'f'},
+                    {"top",    required_argument, nullptr, 'k'},
+                    {"help",   no_argument,       nullptr, 'h'},
+                    {nullptr,  no_argument,       nullptr, '\0'},
+            };
+            int option_index = -1;
+
+            size_t len = 10, freq = 2, k = 10;
+
+            int c;
+            while ((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+                switch (c) {
+                    case 'l': {
+                        len = stoul(optarg);
+                        break;
+                    }
+
+                    case 'f': {
+                        freq = stoul(optarg);
+                        break;
+                    }
+
+                    case 'k': {
+                        k = stoul(optarg);
+                        break;
+                    }
+
+                    case 'h':
+                    case '?':
+                    default: {
+                        help_stats(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+
+            if (optind + 2 >= argc) {
+                help_stats(argv[0]);
+                return 1;
+            }
+
+            string query = argv[optind + 1];
+            string idx_file = argv[optind + 2];
+
+            auto sa = new suffix_array();
+            vector<size_t> lcp;
+
+            if (query == "longest") {
+                sa->load_lcp(idx_file, lcp);
+                sa->longest_repeats(lcp);
+            } else if (query == "repeats") {
+                sa->load_lcp(idx_file, lcp);
+                sa->maximal_repeats(lcp, len, freq);
+            } else if (query == "top") {
+                sa->load_lcp(idx_file, lcp);
+                sa->top_substrings(lcp, len, k);
+            } else if (query == "distinct") {
+                sa->load_lcp(idx_file, lcp);
+                cout << sa->distinct_substrings(lcp) << endl;
+            } else {
+                help_stats(argv[0]);
+                return 1;
+            }
+
+            return 0;
+        }
+
+        case 'g': { // grep
+            const char *short_options = "p:ch";
+            const option long_options[] = {
+                    {"pattern", required_argument, nullptr, 'p'},
+                    {"count",   no_argument,       nullptr, 'c'},
+                    {"help",    no_argument,       nullptr, 'h'},
+                    {nullptr,   no_argument,       nullptr, '\0'},
+            };
+            int option_index = -1;
+
+            size_t m = options::DEFAULT;
+            bool from_file = false;
+
+            list <string> patterns;
+
+            int c;
+            while ((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+                switch (c) {
+                    case 'p': {
+                        ifstream ifs(optarg);
+                        string s;
+                        while (ifs >> s)
+                            patterns.emplace_back(s);
+                        from_file = true;
+                        break;
+                    }
+
+                    case 'c': {
+                        m |= options::COUNT;
+                        break;
+                    }
+
+                    case 'h':
+                    case '?':
+                    default: {
+                        help_grep(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+
+            auto i = static_cast<size_t>(optind) + 1;
+            if (!from_file && i < argc)
+                patterns.emplace_back(argv[i++]);
+
+            if (patterns.empty()) {
+                help_grep(argv[0]);
+                return 1;
+            }
+
+            string in_file = i < argc ? argv[i] : "-";
+
+            aho_corasick ac(patterns);
+
+            size_t no_occ;
+            if (in_file == "-") {
+                no_occ = ac.search(!(m & options::COUNT), cin);
+            } else {
+                ifstream in(in_file, ios::in | ios::binary);
+                if (!in) {
+                    cerr << "Could not open " << in_file << endl;
+                    return EXIT_FAILURE;
+                }
+                no_occ = ac.search(!(m & options::COUNT), in);
+            }
+
+            if (m & options::COUNT)
+                cout << no_occ;
 
             return 0;
         }
 
         case 'z': { // zip
-            const char *short_options = ":h";
+            const char *short_options = ":ch";
             const option long_options[] = {
-                    {"help",  no_argument, nullptr, 'h'},
-                    {nullptr, no_argument, nullptr, '\0'},
+                    {"stdout", no_argument, nullptr, 'c'},
+                    {"help",   no_argument, nullptr, 'h'},
+                    {nullptr,  no_argument, nullptr, '\0'},
             };
             int option_index = -1;
 
+            bool to_stdout = false;
+
             int c;
             while ((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
                 switch (c) {
+                    case 'c': {
+                        to_stdout = true;
+                        break;
+                    }
+
                     case 'h':
                     case '?':
                     default: {
@@ -222,33 +473,50 @@ int main(int argc, char *argv[]) {
                     }
                 }
 
-            string in_file = argv[++optind];
-            string out_file = in_file + ".lz77";
+            string in_file = optind + 1 < argc ? argv[optind + 1] : "-";
 
-            stringstream ss;
-            ss << ifstream(in_file).rdbuf();
-            string str = ss.str();
-            string_view strv{str.c_str(), str.size()};
+            if (in_file == "-") {
+                lz77::zip(cin, cout);
+                return 0;
+            }
+
+            ifstream in(in_file, ios::in | ios::binary);
+            if (!in) {
+                cerr << "Could not open " << in_file << endl;
+                return EXIT_FAILURE;
+            }
 
-            ofstream(out_file, ios::trunc); // clear file
-            ofstream out(out_file, ios::out | ios::binary | ios::app);
+            size_t n = filesystem::is_regular_file(in_file) ? filesystem::file_size(in_file) : lz77::unknown_size;
 
-            lz77::zip(strv, out);
+            if (to_stdout) {
+                lz77::zip(in, cout, n);
+            } else {
+                ofstream out(in_file + ".lz77", ios::out | ios::binary | ios::trunc);
+                lz77::zip(in, out, n);
+            }
 
             return 0;
         }
 
         case 'u': { // unzip
-            const char *short_options = ":h";
+            const char *short_options = ":ch";
             const option long_options[] = {
-                    {"help",  no_argument, nullptr, 'h'},
-                    {nullptr, no_argument, nullptr, '\0'},
+                    {"stdout", no_argument, nullptr, 'c'},
+                    {"help",   no_argument, nullptr, 'h'},
+                    {nullptr,  no_argument, nullptr, '\0'},
             };
             int option_index = -1;
 
+            bool to_stdout = false;
+
             int c;
             while ((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
                 switch (c) {
+                    case 'c': {
+                        to_stdout = true;
+                        break;
+                    }
+
                     case 'h':
                     case '?':
                     default: {
@@ -257,10 +525,30 @@ int main(int argc, char *argv[]) {
                     }
                 }
 
-            string in_file = argv[++optind];
+            string in_file = optind + 1 < argc ? argv[optind + 1] : "-";
+
+            if (in_file == "-") {
+                lz77::unzip(cin, cout);
+                return 0;
+            }
+
+            ifstream in(in_file, ios::in | ios::binary);
+            if (!in) {
+                cerr << "Could not open " << in_file << endl;
+                return EXIT_FAILURE;
+            }
 
-            ifstream in(in_file);
-            lz77::unzip(in);
+            if (to_stdout) {
+                lz77::unzip(in, cout);
+            } else {
+                const string ext = ".lz77";
+                string out_file = in_file.size() > ext.size() && in_file.compare(in_file.size() - ext.size(), ext.size(), ext) == 0
+                                  ? in_file.substr(0, in_file.size() - ext.size())
+                                  : in_file + ".out";
+
+                ofstream out(out_file, ios::out | ios::binary | ios::trunc);
+                lz77::unzip(in, out);
+            }
 
             return 0;
         }
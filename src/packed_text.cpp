@@ -0,0 +1,115 @@
+#include "packed_text.h"
+
+packed_text::packed_text(const string_view &txt, const vector<unsigned char> &alphabet)
+        : n(txt.size()), bits(bits_for(alphabet.size())), alphabet(alphabet) {
+    build_codes();
+
+    words.assign((n * bits + 63) / 64 + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+        pack(words, i, bits, codes[static_cast<unsigned char>(txt[i])]);
+}
+
+size_t packed_text::bits_for(size_t alphabet_size) {
+    size_t b = 1;
+    while ((static_cast<size_t>(1) << b) < alphabet_size)
+        ++b;
+
+    return b;
+}
+
+void packed_text::build_codes() {
+    codes.assign(256, no_code);
+    for (size_t c = 0; c < alphabet.size(); ++c)
+        codes[alphabet[c]] = static_cast<unsigned char>(c);
+}
+
+void packed_text::pack(vector<uint64_t> &w, size_t i, size_t bits, uint64_t c) {
+    size_t bit = i * bits;
+    size_t j = bit >> 6u;
+    size_t off = bit & 63u;
+
+    w[j] |= c << off;
+    if (off + bits > 64)
+        w[j + 1] |= c >> (64 - off);
+}
+
+uint64_t packed_text::window(const vector<uint64_t> &w, size_t bit) {
+    size_t j = bit >> 6u;
+    size_t off = bit & 63u;
+
+    if (off == 0)
+        return w[j];
+
+    return (w[j] >> off) | (w[j + 1] << (64 - off));
+}
+
+size_t packed_text::size() const {
+    return n;
+}
+
+char packed_text::operator[](size_t i) const {
+    uint64_t mask = (static_cast<uint64_t>(1) << bits) - 1;
+    return static_cast<char>(alphabet[window(words, i * bits) & mask]);
+}
+
+void packed_text::set_pattern(const string_view &pat) {
+    pat_words.assign((pat.size() * bits + 63) / 64 + 1, 0);
+
+    // only the prefix made of alphabet symbols can ever match
+    pat_len = 0;
+    while (pat_len < pat.size() && codes[static_cast<unsigned char>(pat[pat_len])] != no_code) {
+        pack(pat_words, pat_len, bits, codes[static_cast<unsigned char>(pat[pat_len])]);
+        ++pat_len;
+    }
+}
+
+size_t packed_text::lcp(size_t pos, const string_view &pat, size_t start_from) const {
+    const size_t per_word = 64 / bits;
+    const size_t limit = min(min(pat_len, pat.size()), n - pos);
+
+    size_t i = start_from;
+    while (i < limit) {
+        size_t k = min(per_word, limit - i);
+        uint64_t x = window(words, (pos + i) * bits) ^ window(pat_words, i * bits);
+        if (k * bits < 64)
+            x &= (static_cast<uint64_t>(1) << (k * bits)) - 1;
+
+        if (x != 0)
+            return i + static_cast<size_t>(__builtin_ctzll(x)) / bits;
+
+        i += k;
+    }
+
+    return i;
+}
+
+void packed_text::save(ostream &out) const {
+    size_t size;
+
+    out.write(reinterpret_cast<const char *>(&n), sizeof(size_t));
+
+    size = alphabet.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(alphabet.data()), size);
+
+    size = words.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(words.data()), sizeof(uint64_t) * size);
+}
+
+void packed_text::load(istream &in) {
+    size_t size;
+
+    in.read(reinterpret_cast<char *>(&n), sizeof(size_t));
+
+    in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    alphabet.resize(size);
+    in.read(reinterpret_cast<char *>(alphabet.data()), size);
+
+    in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    words.resize(size);
+    in.read(reinterpret_cast<char *>(words.data()), sizeof(uint64_t) * size);
+
+    bits = bits_for(alphabet.size());
+    build_codes();
+}
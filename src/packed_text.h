@@ -0,0 +1,53 @@
+#ifndef IPMT_PACKED_TEXT_H
+#define IPMT_PACKED_TEXT_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Text over a small remapped alphabet, stored with a fixed number of bits per symbol
+class packed_text {
+private:
+    static const unsigned char no_code = 0xff;
+
+    size_t n = 0;
+    size_t bits = 0;
+    vector<unsigned char> alphabet;
+    vector<unsigned char> codes;
+    vector<uint64_t> words;
+
+    vector<uint64_t> pat_words;
+    size_t pat_len = 0;
+
+    static void pack(vector<uint64_t> &w, size_t i, size_t bits, uint64_t c);
+
+    static uint64_t window(const vector<uint64_t> &w, size_t bit);
+
+    void build_codes();
+
+public:
+    static const size_t max_bits = 5;
+
+    packed_text() = default;
+
+    packed_text(const string_view &txt, const vector<unsigned char> &alphabet);
+
+    static size_t bits_for(size_t alphabet_size);
+
+    size_t size() const;
+
+    char operator[](size_t i) const;
+
+    void set_pattern(const string_view &pat);
+
+    size_t lcp(size_t pos, const string_view &pat, size_t start_from) const;
+
+    void save(ostream &out) const;
+
+    void load(istream &in);
+};
+
+#endif //IPMT_PACKED_TEXT_H
@@ -23,21 +23,39 @@ void suffix_array::sort_index(vector<size_t> &index, vector<T> &ranking) {
     }
 }
 
+void suffix_array::build_alphabet() {
+    vector<size_t> byte_count(256);
+
+    for (auto &c : strv)
+        ++byte_count[static_cast<unsigned char>(c)];
+
+    alphabet.clear();
+    char_count.clear();
+    for (size_t c = 0; c < byte_count.size(); ++c) {
+        if (byte_count[c] == 0)
+            continue;
+
+        alphabet.push_back(static_cast<unsigned char>(c));
+        char_count.push_back(byte_count[c]);
+    }
+
+    total_char_count = strv.size();
+}
+
 void suffix_array::build_inv_sa(vector<size_t> &inv_sa) {
     size_t n = strv.size();
 
     vector<vector<size_t>> index(2, vector<size_t>(n));
 
-    vector<char> str_vector = vector<char>(n);
-    char_count = vector<size_t>(127);
+    build_alphabet();
 
-    for (size_t i = 0; i < n; ++i) {
-        str_vector[i] = strv[i];
-        ++char_count[strv[i]];
-        ++total_char_count;
-    }
+    // the remapped symbols are already dense ranks
+    vector<size_t> code(256);
+    for (size_t c = 0; c < alphabet.size(); ++c)
+        code[alphabet[c]] = c;
 
-    sort_index<char>(index[0], str_vector);
+    for (size_t i = 0; i < n; ++i)
+        index[0][i] = code[static_cast<unsigned char>(strv[i])];
 
     bool b = false;
     auto ceil_log_n = ceil(log2(n));
@@ -125,14 +143,12 @@ suffix_array::suffix_array() {}
 void suffix_array::recover_str() {
     string _str(total_char_count, ' ');
     size_t si = -1;
-    size_t size = 0;
 
     for (size_t i = 0; i < char_count.size(); ++i) {
         size_t j = 0;
         while (j < char_count[i]) {
-            _str[sa[++si]] = char(i);
+            _str[sa[++si]] = static_cast<char>(alphabet[i]);
             ++j;
-            ++size;
         }
 
     }
@@ -157,52 +173,65 @@ size_t suffix_array::lcp(string_view &str1, string_view &str2, size_t start_from
     return i + start_from;
 }
 
+char suffix_array::at(size_t i) {
+    if (compressed)
+        return ztext[i];
+
+    return packed ? ptext[i] : strv[i];
+}
+
+size_t suffix_array::lcp(size_t pos, string_view &pat, size_t start_from) {
+    if (compressed)
+        return ztext.lcp(pos, pat, start_from);
+
+    if (packed)
+        return ptext.lcp(pos, pat, start_from);
+
+    string_view suffix = strv.substr(pos);
+    return lcp(suffix, pat, start_from);
+}
+
+int suffix_array::compare(size_t pos, string_view &pat, size_t &matched) {
+    matched = lcp(pos, pat, 0);
+    if (matched == min(pat.size(), sa.size() - pos))
+        return 0;
+
+    return static_cast<unsigned char>(at(pos + matched)) < static_cast<unsigned char>(pat[matched]) ? -1 : 1;
+}
+
 size_t suffix_array::pred(string_view &pat) {
-    size_t n = strv.size();
+    size_t n = sa.size();
     size_t m = pat.size();
 
-    size_t _min;
+    size_t l, r, L, R, H;
 
-    string_view l_str = strv.substr(sa[0]);
-    _min = min(m, l_str.size());
-    if (l_str.substr(0, _min) > pat.substr(0, _min)) {
+    if (compare(sa[0], pat, L) > 0)
         return -1;
-    }
 
-    string_view r_str = strv.substr(sa[n - 1]);
-    _min = min(m, r_str.size());
-    if (r_str.substr(0, _min) <= pat.substr(0, _min)) {
+    if (compare(sa[n - 1], pat, R) <= 0)
         return n - 1;
-    }
-
-    size_t l, r, L, R, H;
-    string_view aux;
 
     l = 0;
     r = n - 1;
-    L = lcp(l_str, pat, 0);
-    R = lcp(r_str, pat, 0);
     while (r - l > 1) {
         size_t h = (l + r) / 2;
         if (L >= R) {
             if (L < l_lcp[h])
                 H = L;
-            else if (L == l_lcp[h]) {
-                aux = strv.substr(sa[h]);
-                H = lcp(aux, pat, L);
-            } else
+            else if (L == l_lcp[h])
+                H = lcp(sa[h], pat, L);
+            else
                 H = l_lcp[h];
         } else {
             if (R < r_lcp[h])
                 H = R;
-            else if (R == r_lcp[h]) {
-                aux = strv.substr(sa[h]);
-                H = lcp(aux, pat, R);
-            } else
+            else if (R == r_lcp[h])
+                H = lcp(sa[h], pat, R);
+            else
                 H = r_lcp[h];
         }
 
-        if (H == m || (H < n - sa[h] && strv[sa[h] + H] <= pat[H])) {
+        if (H == m || (H < n - sa[h] && static_cast<unsigned char>(at(sa[h] + H)) <= static_cast<unsigned char>(pat[H]))) {
             l = h;
             L = H;
         } else {
@@ -216,52 +245,38 @@ size_t suffix_array::pred(string_view &pat) {
 
 
 size_t suffix_array::succ(string_view &pat) {
-    size_t n = strv.size();
+    size_t n = sa.size();
     size_t m = pat.size();
 
-    size_t _min;
+    size_t l, r, L, R, H;
 
-    string_view l_str = strv.substr(sa[0]);
-    _min = min(m, l_str.size());
-    if (l_str.substr(0, _min) >= pat.substr(0, _min)) {
+    if (compare(sa[0], pat, L) >= 0)
         return 0;
-    }
 
-    string_view r_str = strv.substr(sa[n - 1]);
-    _min = min(m, r_str.size());
-    if (r_str.substr(0, _min) < pat.substr(0, _min)) {
+    if (compare(sa[n - 1], pat, R) < 0)
         return n;
-    }
-
-    size_t l, r, L, R, H;
-    string_view aux;
 
     l = 0;
     r = n - 1;
-    L = lcp(l_str, pat, 0);
-    R = lcp(r_str, pat, 0);
-
     while (r - l > 1) {
         size_t h = (l + r) / 2;
         if (L >= R) {
             if (L < l_lcp[h])
                 H = L;
-            else if (L == l_lcp[h]) {
-                aux = strv.substr(sa[h]);
-                H = lcp(aux, pat, L);
-            } else
+            else if (L == l_lcp[h])
+                H = lcp(sa[h], pat, L);
+            else
                 H = l_lcp[h];
         } else {
             if (R < r_lcp[h])
                 H = R;
-            else if (R == r_lcp[h]) {
-                aux = strv.substr(sa[h]);
-                H = lcp(aux, pat, R);
-            } else
+            else if (R == r_lcp[h])
+                H = lcp(sa[h], pat, R);
+            else
                 H = r_lcp[h];
         }
 
-        if (H == m || (sa[h] + H < n && pat[H] <= strv[sa[h] + H])) {
+        if (H == m || (sa[h] + H < n && static_cast<unsigned char>(pat[H]) <= static_cast<unsigned char>(at(sa[h] + H)))) {
             r = h;
             R = H;
         } else {
@@ -274,10 +289,20 @@ size_t suffix_array::succ(string_view &pat) {
 }
 
 
-void suffix_array::save(const string &indexFilePath) {
+void suffix_array::save(const string &indexFilePath, bool compress) {
     ofstream out(indexFilePath, ios::out | ios::binary | ios::trunc);
     size_t size;
 
+    size_t magic = index_magic;
+    size_t flags = byte_alphabet;
+    if (compress)
+        flags |= lz77_text;
+    else if (packed_text::bits_for(alphabet.size()) <= packed_text::max_bits)
+        flags |= bit_packed_text;
+
+    out.write(reinterpret_cast<const char *>(&magic), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(&flags), sizeof(size_t));
+
     size = sa.size();
     out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
     out.write(reinterpret_cast<const char *>(sa.data()), sizeof(size_t) * size);
@@ -290,18 +315,35 @@ void suffix_array::save(const string &indexFilePath) {
     out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
     out.write(reinterpret_cast<const char *>(r_lcp.data()), sizeof(size_t) * size);
 
-    out.write(reinterpret_cast<const char *>(char_count.data()), sizeof(size_t) * 127);
+    if (flags & lz77_text) {
+        block_text(strv).save(out);
+        return;
+    }
+
+    if (flags & bit_packed_text) {
+        packed_text(strv, alphabet).save(out);
+        return;
+    }
+
+    size = alphabet.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size_t));
+    out.write(reinterpret_cast<const char *>(alphabet.data()), size);
+    out.write(reinterpret_cast<const char *>(char_count.data()), sizeof(size_t) * size);
 
     out.write(reinterpret_cast<const char *>(&total_char_count), sizeof(size_t));
 }
 
-size_t suffix_array::search(bool print, string &indexFilePath, list<string> &patterns) {
+void suffix_array::load(const string &indexFilePath) {
     ifstream in(indexFilePath, ios::in | ios::binary);
 
-    size_t no_occ = 0;
-    size_t size, char_count_size = 127;
+    size_t size, flags = 0;
 
     in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    if (size == index_magic) {
+        in.read(reinterpret_cast<char *>(&flags), sizeof(size_t));
+        in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+    } // else: index written before the header existed
+
     sa.resize(size);
     in.read(reinterpret_cast<char *>(sa.data()), sizeof(size_t) * size);
 
@@ -313,37 +355,300 @@ size_t suffix_array::search(bool print, string &indexFilePath, list<string> &pat
     r_lcp.resize(size);
     in.read(reinterpret_cast<char *>(r_lcp.data()), sizeof(size_t) * size);
 
-    char_count.resize(127);
-    in.read(reinterpret_cast<char *>(char_count.data()), sizeof(size_t) * 127);
+    compressed = flags & lz77_text;
+    if (compressed) {
+        ztext.load(in);
+        return;
+    }
+
+    packed = flags & bit_packed_text;
+    if (packed) {
+        ptext.load(in);
+        return;
+    }
+
+    if (flags & byte_alphabet) {
+        in.read(reinterpret_cast<char *>(&size), sizeof(size_t));
+        alphabet.resize(size);
+        in.read(reinterpret_cast<char *>(alphabet.data()), size);
+    } else { // 7-bit ASCII counters indexed by the character itself
+        size = 127;
+        alphabet.resize(size);
+        for (size_t c = 0; c < size; ++c)
+            alphabet[c] = static_cast<unsigned char>(c);
+    }
+
+    char_count.resize(size);
+    in.read(reinterpret_cast<char *>(char_count.data()), sizeof(size_t) * size);
 
     in.read(reinterpret_cast<char *>(&total_char_count), sizeof(size_t));
 
     recover_str();
+}
+
+void suffix_array::print_line(size_t pos) {
+    const size_t n = sa.size();
+
+    size_t begin = pos;
+    while (begin > 0 && at(begin - 1) != '\n')
+        --begin;
+
+    size_t end = pos;
+    while (end < n && at(end) != '\n')
+        ++end;
+
+    for (size_t i = begin; i < end; ++i)
+        cout << at(i);
+    cout << endl;
+}
+
+void suffix_array::radix_sort(vector<size_t> &v) {
+    vector<size_t> tmp(v.size());
+    size_t max_v = v.empty() ? 0 : *max_element(v.begin(), v.end());
+
+    for (size_t shift = 0; shift < 64 && (max_v >> shift) > 0; shift += 8) {
+        vector<size_t> count(257, 0);
+        for (auto &x : v)
+            ++count[((x >> shift) & 0xffu) + 1];
+
+        for (size_t d = 1; d < count.size(); ++d)
+            count[d] += count[d - 1];
+
+        for (auto &x : v)
+            tmp[count[(x >> shift) & 0xffu]++] = x;
+
+        v.swap(tmp);
+    }
+}
+
+void suffix_array::print_sorted(vector<pair<size_t, size_t>> &intervals, size_t offset, size_t limit) {
+    vector<size_t> hits;
+
+    if (limit == 0)
+        return;
+
+    if (limit <= heap_select_limit) {
+        // keep only the first limit positions in a max-heap
+        priority_queue<size_t> top;
+        for (auto &in : intervals)
+            for (size_t i = in.first; i <= in.second; ++i) {
+                if (top.size() < limit) {
+                    top.push(sa[i]);
+                } else if (sa[i] < top.top()) {
+                    top.pop();
+                    top.push(sa[i]);
+                }
+            }
+
+        hits.resize(top.size());
+        for (size_t i = hits.size(); i > 0; --i) {
+            hits[i - 1] = top.top();
+            top.pop();
+        }
+    } else {
+        for (auto &in : intervals)
+            hits.insert(hits.end(), sa.begin() + in.first, sa.begin() + in.second + 1);
+
+        radix_sort(hits);
+    }
+
+    for (size_t i = offset; i < min(limit, hits.size()); ++i)
+        print_line(hits[i]);
+}
+
+size_t suffix_array::search(bool print, string &indexFilePath, list<string> &patterns, size_t offset,
+                            size_t max_occ, bool sorted) {
+    size_t no_occ = 0;
+    const size_t limit = max_occ > unlimited - offset ? unlimited : offset + max_occ;
+
+    // with sorted output every interval is needed before the first line can be printed
+    const bool collect = print && sorted;
+    vector<pair<size_t, size_t>> intervals;
+
+    load(indexFilePath);
 
     for (auto &p : patterns) {
+        if (!collect && no_occ >= limit)
+            break;
+
         string_view pv{p.c_str(), p.size()};
 
+        if (packed)
+            ptext.set_pattern(pv);
+
         size_t rp = pred(pv);
         size_t lp = succ(pv);
 
         if (lp + 1 > rp + 1)
             continue;
 
-        if (print) {
-            while (lp <= rp) {
-                size_t sa_value = sa[lp];
-                while (strv.at(--sa_value) != '\n');
+        size_t occ = rp - lp + 1;
 
-                while (strv.at(++sa_value) != '\n')
-                    cout << strv[sa_value];
-                cout << endl;
+        if (collect) {
+            intervals.emplace_back(lp, rp);
+        } else if (print) {
+            size_t from = no_occ < offset ? min(offset - no_occ, occ) : 0;
+            size_t to = min(occ, limit - no_occ);
+            for (size_t i = from; i < to; ++i)
+                print_line(sa[lp + i]);
+        }
+
+        no_occ += occ;
+    }
+
+    if (collect)
+        print_sorted(intervals, offset, limit);
+
+    return no_occ > offset ? min(no_occ, limit) - offset : 0;
+}
+
+void suffix_array::materialize_text() {
+    if (!compressed && !packed)
+        return;
+
+    const size_t n = sa.size();
+
+    str_ref.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        str_ref[i] = at(i);
+
+    string_view s{str_ref.c_str(), str_ref.size()};
+    strv = s;
+
+    compressed = false;
+    packed = false;
+}
+
+void suffix_array::print_substring(size_t pos, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+
+    for (size_t i = pos; i < pos + len; ++i) {
+        auto c = static_cast<unsigned char>(at(i));
+        if (c == '\n')
+            cout << "\\n";
+        else if (c == '\t')
+            cout << "\\t";
+        else if (c == '\\')
+            cout << "\\\\";
+        else if (c < 0x20 || c == 0x7f)
+            cout << "\\x" << hex[c >> 4u] << hex[c & 0xfu];
+        else
+            cout << c;
+    }
+}
+
+void suffix_array::load_lcp(string &indexFilePath, vector<size_t> &lcp) {
+    load(indexFilePath);
+    materialize_text();
+
+    vector<size_t> inv_sa(sa.size());
+    for (size_t i = 0; i < sa.size(); ++i)
+        inv_sa[sa[i]] = i;
 
-                ++lp;
+    build_lcp(lcp, inv_sa);
+}
+
+void suffix_array::longest_repeats(vector<size_t> &lcp) {
+    size_t longest = 0;
+    for (auto &l : lcp)
+        longest = max(longest, l);
+
+    if (longest == 0)
+        return;
+
+    // each run of maximal lcp values is one distinct longest repeat
+    for (size_t i = 0; i < lcp.size(); ++i) {
+        if (lcp[i] != longest)
+            continue;
+
+        size_t j = i;
+        while (j < lcp.size() && lcp[j] == longest)
+            ++j;
+
+        cout << longest << '\t' << j - i + 1 << '\t';
+        print_substring(sa[i], longest);
+        cout << endl;
+
+        i = j;
+    }
+}
+
+void suffix_array::maximal_repeats(vector<size_t> &lcp, size_t min_len, size_t min_freq) {
+    const size_t n = sa.size();
+
+    // diverse[j] counts positions up to j whose preceding character differs from the one at j - 1
+    auto bwt = [this](size_t j) {
+        return sa[j] == 0 ? 256 : static_cast<size_t>(static_cast<unsigned char>(strv[sa[j] - 1]));
+    };
+    vector<size_t> diverse(n, 0);
+    for (size_t j = 1; j < n; ++j)
+        diverse[j] = diverse[j - 1] + (bwt(j) != bwt(j - 1));
+
+    // bottom-up traversal of the lcp-intervals
+    vector<pair<size_t, size_t>> st; // (lcp, left bound)
+    st.emplace_back(0, 0);
+
+    for (size_t i = 1; i <= n; ++i) {
+        size_t cur = i < n ? lcp[i - 1] : 0;
+        size_t lb = i - 1;
+
+        while (cur < st.back().first) {
+            size_t len = st.back().first;
+            lb = st.back().second;
+            st.pop_back();
+
+            size_t freq = i - lb;
+            if (len >= min_len && freq >= min_freq && diverse[i - 1] > diverse[lb]) {
+                cout << len << '\t' << freq << '\t';
+                print_substring(sa[lb], len);
+                cout << endl;
             }
-        } else {
-            no_occ += rp - lp + 1;
         }
+
+        if (cur > st.back().first)
+            st.emplace_back(cur, lb);
+    }
+}
+
+void suffix_array::top_substrings(vector<size_t> &lcp, size_t len, size_t k) {
+    const size_t n = sa.size();
+
+    // min-heap of (frequency, suffix array position) holding the current top k
+    priority_queue<pair<size_t, size_t>, vector<pair<size_t, size_t>>, greater<>> top;
+
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j + 1 < n && lcp[j] >= len)
+            ++j;
+
+        if (n - sa[i] >= len) {
+            top.emplace(j - i + 1, i);
+            if (top.size() > k)
+                top.pop();
+        }
+
+        i = j + 1;
+    }
+
+    vector<pair<size_t, size_t>> result;
+    while (!top.empty()) {
+        result.push_back(top.top());
+        top.pop();
+    }
+
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+        cout << it->first << '\t';
+        print_substring(sa[it->second], len);
+        cout << endl;
     }
+}
+
+size_t suffix_array::distinct_substrings(vector<size_t> &lcp) {
+    const size_t n = sa.size();
+
+    size_t total = n * (n + 1) / 2;
+    for (auto &l : lcp)
+        total -= l;
 
-    return no_occ;
+    return total;
 }
@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <fstream>
 #include <list>
+#include <queue>
+#include "block_text.h"
+#include "packed_text.h"
 
 using namespace std;
 
@@ -15,6 +18,8 @@ private:
     template<class T>
     void sort_index(vector<size_t> &index, vector<T> &ranking);
 
+    void build_alphabet();
+
     void build_inv_sa(vector<size_t> &inv_sa);
 
     void invert_inv_sa(vector<size_t> &inv_sa);
@@ -27,14 +32,44 @@ private:
 
     void recover_str();
 
+    void load(const string &indexFilePath);
+
+    char at(size_t i);
+
+    size_t lcp(size_t pos, string_view &pat, size_t start_from);
+
+    int compare(size_t pos, string_view &pat, size_t &matched);
+
+    void print_line(size_t pos);
+
+    void print_substring(size_t pos, size_t len);
+
+    void materialize_text();
+
+    static void radix_sort(vector<size_t> &v);
+
+    void print_sorted(vector<pair<size_t, size_t>> &intervals, size_t offset, size_t limit);
+
 public:
+    static const size_t index_magic = 0x31786469746d7069; // "ipmtidx1"
+    static const size_t lz77_text = 0x01;
+    static const size_t bit_packed_text = 0x02;
+    static const size_t byte_alphabet = 0x04;
+    static const size_t unlimited = static_cast<size_t>(-1);
+    static const size_t heap_select_limit = static_cast<size_t>(1) << static_cast<size_t>(16);
+
     vector<size_t> sa;
     vector<size_t> l_lcp;
     vector<size_t> r_lcp;
+    vector<unsigned char> alphabet;
     vector<size_t> char_count;
     size_t total_char_count = 0;
     string_view strv;
     string str_ref;
+    block_text ztext;
+    bool compressed = false;
+    packed_text ptext;
+    bool packed = false;
 
     size_t lcp(string_view &str1, string_view &str2, size_t start_from);
 
@@ -46,9 +81,20 @@ public:
 
     explicit suffix_array();
 
-    void save(const string &indexFilePath);
+    void save(const string &indexFilePath, bool compress = false);
+
+    size_t search(bool print, string &indexFilePath, list<string> &patterns, size_t offset = 0,
+                  size_t max_occ = unlimited, bool sorted = false);
+
+    void load_lcp(string &indexFilePath, vector<size_t> &lcp);
+
+    void longest_repeats(vector<size_t> &lcp);
+
+    void maximal_repeats(vector<size_t> &lcp, size_t min_len, size_t min_freq);
+
+    void top_substrings(vector<size_t> &lcp, size_t len, size_t k);
 
-    size_t search(bool print, string &indexFilePath, list<string> &patterns);
+    size_t distinct_substrings(vector<size_t> &lcp);
 };
 
 